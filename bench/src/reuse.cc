@@ -0,0 +1,69 @@
+#include <json_parser.hpp>
+
+#include <chrono>
+#include <sstream>
+#include <string>
+#include <iostream>
+
+// parses the same ~1 KB document repeatedly through the free parse
+// function, a single reused parser, and a reused parser writing into the
+// same value each time
+std::string make_document()
+{
+  std::string doc = "{\"items\": [";
+
+  for (int i = 0; i < 12; i++) {
+    if (i > 0) {
+      doc += ", ";
+    }
+    doc += "{\"id\": " + std::to_string(i) + ", \"name\": \"item number " + std::to_string(i) +
+      "\", \"price\": 12.5e-1, \"tags\": [\"a\", \"b\"], \"active\": true}";
+  }
+
+  doc += "], \"next\": null}";
+  return doc;
+}
+
+template <typename Parse>
+void run(const char* name, std::istringstream& input, int iterations, Parse parse)
+{
+  auto start = std::chrono::steady_clock::now();
+
+  for (int i = 0; i < iterations; i++) {
+    input.clear();
+    input.seekg(0);
+    parse(input);
+  }
+
+  std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+  std::cout << name << ": " << elapsed.count() / iterations << " ns/doc" << std::endl;
+
+#ifdef JSON_PARSER_STATS
+  json_parser::parse_stats stats;
+  input.clear();
+  input.seekg(0);
+  parse(input, stats);
+  std::cout << name << ": " << stats.allocations << " allocations/doc, " << stats.bytes_allocated << " bytes/doc" << std::endl;
+#endif
+}
+
+int main()
+{
+  const int iterations = 100000;
+  std::istringstream input(make_document());
+  std::cout << "document size: " << input.str().size() << " bytes" << std::endl;
+
+  run("parse", input, iterations, [](std::istream& in, auto&... stats) {
+    json_parser::parse(in, stats...);
+  });
+
+  json_parser::parser reused;
+  run("parser", input, iterations, [&](std::istream& in, auto&... stats) {
+    reused.parse(in, stats...);
+  });
+
+  json_parser::value document;
+  run("parser into value", input, iterations, [&](std::istream& in, auto&... stats) {
+    reused.parse(in, document, stats...);
+  });
+}
@@ -1,21 +1,36 @@
 #ifndef PACKRAT_JSON
 #define PACKRAT_JSON
 
+#include <cstdint>
 #include <map>
+#include <memory>
 #include <vector>
 
 #include <string>
 #include <iostream>
+#include <utility>
+
+#ifdef JSON_PARSER_STATS
+#include <array>
+#include <chrono>
+#endif
 
 #include <boost/variant.hpp>
 #include <boost/none.hpp>
 
 namespace json_parser {
+  // LBRACE and RBRACE are { and }, LBRACKET and RBRACKET are [ and ].
+  // COUNT is the number of token types, not a token.
+  enum class token_type { TRUE, FALSE, NULL_TOKEN, STRING, NUMBER, LBRACE, RBRACE, LBRACKET, RBRACKET, COLON, COMMA, COUNT };
+
+  // deepest nesting accepted by parse, validate and binary documents
+  const std::size_t max_depth = 1024;
+
   class value {
   public:
-    value(std::map<std::string, value> m) : data(m) {}
-    value(std::vector<value> v) : data(v) {}
-    value(std::string s) : data(s) {}
+    value(std::map<std::string, value> m) : data(std::move(m)) {}
+    value(std::vector<value> v) : data(std::move(v)) {}
+    value(std::string s) : data(std::move(s)) {}
     value(double d) : data(d) {}
     value(bool b) : data(b) {}
     value() : data(boost::none) {}
@@ -34,10 +49,122 @@ namespace json_parser {
     bool is_null();
 
   private:
+    friend class binary_writer;
+    friend class value_builder;
+
     boost::variant<boost::none_t, bool, double, std::string, std::vector<value>, std::map<std::string, value>> data;
   };
 
   value parse(std::istream& input);
+
+  // checks that input is well-formed JSON without building a value. it
+  // succeeds exactly when parse would: numbers outside double range pass
+  // both, and parse rounds them to +-infinity or zero.
+  bool validate(std::istream& input);
+
+#ifdef JSON_PARSER_STATS
+  // per-parse counters, only available when built with JSON_PARSER_STATS.
+  // allocations and bytes_allocated stay 0 unless the application also links
+  // build/alloc_stats.o, which replaces the global operator new and then
+  // counts every allocation made on the parsing thread during the call.
+  struct parse_stats {
+    std::size_t bytes_consumed = 0; // 0 when the stream is not seekable
+    std::array<std::size_t, std::size_t(token_type::COUNT)> tokens_by_type = {}; // indexed by token_type
+    std::size_t strings_decoded = 0;
+    std::size_t escapes_decoded = 0;
+    std::size_t numbers_parsed = 0;
+    std::size_t max_depth = 0;
+    std::size_t allocations = 0;
+    std::size_t bytes_allocated = 0;
+    std::chrono::nanoseconds lex_time{0};
+    std::chrono::nanoseconds build_time{0};
+  };
+
+  value parse(std::istream& input, parse_stats& stats);
+#endif
+
+  struct token_list;
+
+  // keeps its internal buffers between calls. parsing into the same value
+  // each time also reuses that value's containers and strings, so similar
+  // documents can be parsed without allocating. if parsing throws, out is
+  // left partly overwritten.
+  class parser {
+  public:
+    parser();
+    parser(parser&&);
+    parser& operator=(parser&&);
+    ~parser();
+
+    value parse(std::istream& input);
+    void parse(std::istream& input, value& out);
+#ifdef JSON_PARSER_STATS
+    value parse(std::istream& input, parse_stats& stats);
+    void parse(std::istream& input, value& out, parse_stats& stats);
+#endif
+
+  private:
+    token_list& reset_tokens();
+
+    std::unique_ptr<token_list> tokens;
+  };
+
+  // binary documents, see src/binary.cc for the layout
+  void write_binary(value& v, std::ostream& output);
+  value read_binary(const char* data, std::size_t size);
+
+  // a node inside a binary document, read in place without copying the
+  // document. the underlying buffer must outlive it.
+  class binary_value {
+  public:
+    binary_value(const char* data, std::size_t size);
+
+    binary_value at(std::string key) const;
+    binary_value at(int i) const;
+    std::string key(int i) const;
+    std::size_t size() const;
+    std::string to_string() const;
+    double to_number() const;
+    bool to_bool() const;
+    value to_value() const;
+
+    bool is_object() const;
+    bool is_array() const;
+    bool is_string() const;
+    bool is_number() const;
+    bool is_boolean() const;
+    bool is_null() const;
+
+  private:
+    binary_value(const char* data, std::size_t size, std::size_t offset);
+
+    value to_value(std::size_t depth, std::size_t& end) const;
+
+    char tag() const;
+    uint32_t read_u32(std::size_t position) const;
+    std::size_t child(int i) const;
+    void expect_child_at(int i, std::size_t position) const;
+    void expect(char expected, const char* name) const;
+
+    const char* data;
+    std::size_t length;
+    std::size_t offset;
+  };
+
+  // memory maps a binary document so it can be read without loading it
+  class mapped_file {
+  public:
+    mapped_file(const std::string& filename);
+    mapped_file(const mapped_file&) = delete;
+    mapped_file& operator=(const mapped_file&) = delete;
+    ~mapped_file();
+
+    binary_value root() const;
+
+  private:
+    const char* data;
+    std::size_t size;
+  };
 }
 
 #endif
@@ -0,0 +1,39 @@
+#include <cstdlib>
+#include <new>
+
+#include "json_parser.hpp"
+
+// Replaces the global operator new so parse_stats can count allocations.
+// This is not part of json_parser.a: applications that want allocation
+// counts link build/alloc_stats.o themselves, and without it
+// parse_stats::allocations and bytes_allocated stay 0.
+
+#ifdef JSON_PARSER_STATS
+namespace json_parser {
+  extern thread_local parse_stats* current_stats;
+}
+
+void* operator new(std::size_t size)
+{
+  if (json_parser::current_stats) {
+    json_parser::current_stats->allocations++;
+    json_parser::current_stats->bytes_allocated += size;
+  }
+
+  if (void* ptr = std::malloc(size ? size : 1)) {
+    return ptr;
+  }
+
+  throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+  std::free(ptr);
+}
+#endif
@@ -0,0 +1,463 @@
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "json_parser.hpp"
+
+// A binary document is the magic "JPB1" followed by the root node. Integers
+// are little-endian and offsets are relative to the start of their node, so
+// any node can be read in place:
+//
+//   null, false, true   tag
+//   number              tag, 8 byte IEEE double
+//   string              tag, u32 length, bytes
+//   array               tag, u32 count, count u32 element offsets, elements
+//   object              tag, u32 count, count u32 entry offsets, entries
+//                       sorted by key, each a u32 key length, key bytes, node
+
+namespace json_parser {
+
+  enum class binary_tag : char { NULL_VALUE, FALSE, TRUE, NUMBER, STRING, ARRAY, OBJECT };
+
+  const char binary_magic[4] = { 'J', 'P', 'B', '1' };
+
+  // binary_writer impl
+  class binary_writer {
+  public:
+    std::string out;
+
+    void write(value& v, std::size_t depth)
+    {
+      if ((v.is_array() || v.is_object()) && depth == max_depth) {
+        throw std::runtime_error("Maximum nesting depth exceeded");
+      }
+
+      switch(v.data.which()) {
+      case 0:
+        out += char(binary_tag::NULL_VALUE);
+        break;
+      case 1:
+        out += char(boost::get<bool>(v.data) ? binary_tag::TRUE : binary_tag::FALSE);
+        break;
+      case 2:
+        write_number(boost::get<double>(v.data));
+        break;
+      case 3:
+        out += char(binary_tag::STRING);
+        write_string(boost::get<std::string>(v.data));
+        break;
+      case 4:
+        write_array(boost::get<std::vector<value>>(v.data), depth + 1);
+        break;
+      case 5:
+        write_object(boost::get<std::map<std::string, value>>(v.data), depth + 1);
+        break;
+      }
+    }
+
+  private:
+    void write_number(double d)
+    {
+      uint64_t bits;
+      std::memcpy(&bits, &d, sizeof(bits));
+
+      out += char(binary_tag::NUMBER);
+      for (int i = 0; i < 8; i++) {
+        out += char(bits >> (8 * i));
+      }
+    }
+
+    void write_string(const std::string& s)
+    {
+      write_u32(size_u32(s.size()));
+      out += s;
+    }
+
+    void write_array(std::vector<value>& values, std::size_t depth)
+    {
+      std::size_t start = begin_container(binary_tag::ARRAY, values.size());
+
+      for (std::size_t i = 0; i < values.size(); i++) {
+        patch_offset(start, i);
+        write(values[i], depth);
+      }
+    }
+
+    void write_object(std::map<std::string, value>& object, std::size_t depth)
+    {
+      std::size_t start = begin_container(binary_tag::OBJECT, object.size());
+      std::size_t i = 0;
+
+      for (auto& entry : object) {
+        patch_offset(start, i++);
+        write_string(entry.first);
+        write(entry.second, depth);
+      }
+    }
+
+    // writes the tag, count and a zeroed offset table, returns the node start
+    std::size_t begin_container(binary_tag tag, std::size_t count)
+    {
+      std::size_t start = out.size();
+
+      out += char(tag);
+      write_u32(size_u32(count));
+      out.append(4 * count, '\0');
+
+      return start;
+    }
+
+    // points the i-th offset of the container at start to the end of out
+    void patch_offset(std::size_t start, std::size_t i)
+    {
+      uint32_t offset = size_u32(out.size() - start);
+
+      for (int b = 0; b < 4; b++) {
+        out[start + 5 + 4 * i + b] = char(offset >> (8 * b));
+      }
+    }
+
+    void write_u32(uint32_t n)
+    {
+      for (int i = 0; i < 4; i++) {
+        out += char(n >> (8 * i));
+      }
+    }
+
+    uint32_t size_u32(std::size_t n)
+    {
+      if (n > UINT32_MAX) {
+        throw std::runtime_error("Value too large for binary document");
+      }
+
+      return uint32_t(n);
+    }
+  };
+
+  void write_binary(value& v, std::ostream& output)
+  {
+    binary_writer writer;
+    writer.out.append(binary_magic, sizeof(binary_magic));
+    writer.write(v, 0);
+
+    output.write(writer.out.data(), writer.out.size());
+  }
+
+  value read_binary(const char* data, std::size_t size)
+  {
+    return binary_value(data, size).to_value();
+  }
+
+  // binary_value impl
+  binary_value::binary_value(const char* data, std::size_t size) :
+    data(data), length(size), offset(sizeof(binary_magic))
+  {
+    if (size <= sizeof(binary_magic) || std::memcmp(data, binary_magic, sizeof(binary_magic)) != 0) {
+      throw std::runtime_error("Invalid binary document");
+    }
+  }
+
+  binary_value::binary_value(const char* data, std::size_t size, std::size_t offset) :
+    data(data), length(size), offset(offset)
+  {}
+
+  binary_value binary_value::at(std::string key) const
+  {
+    expect(char(binary_tag::OBJECT), "object");
+
+    // entries are sorted by key, in the same order as std::map
+    std::size_t low = 0;
+    std::size_t high = size();
+
+    while (low < high) {
+      std::size_t middle = low + (high - low) / 2;
+      std::size_t entry = child(middle);
+      uint32_t key_length = read_u32(entry);
+
+      if (entry + 4 + key_length > length) {
+        throw std::runtime_error("Truncated binary document");
+      }
+
+      int compare = std::string::traits_type::compare(data + entry + 4, key.data(), std::min<std::size_t>(key_length, key.size()));
+      if (compare == 0) {
+        compare = key_length < key.size() ? -1 : key_length > key.size() ? 1 : 0;
+      }
+
+      if (compare == 0) {
+        return binary_value(data, length, entry + 4 + key_length);
+      } else if (compare < 0) {
+        low = middle + 1;
+      } else {
+        high = middle;
+      }
+    }
+
+    throw std::out_of_range(std::string("Key not found: ") + key);
+  }
+
+  binary_value binary_value::at(int i) const
+  {
+    expect(char(binary_tag::ARRAY), "array");
+
+    if (i < 0 || std::size_t(i) >= size()) {
+      throw std::out_of_range("Array index out of range");
+    }
+
+    return binary_value(data, length, child(i));
+  }
+
+  std::string binary_value::key(int i) const
+  {
+    expect(char(binary_tag::OBJECT), "object");
+
+    if (i < 0 || std::size_t(i) >= size()) {
+      throw std::out_of_range("Object index out of range");
+    }
+
+    std::size_t entry = child(i);
+    uint32_t key_length = read_u32(entry);
+
+    if (entry + 4 + key_length > length) {
+      throw std::runtime_error("Truncated binary document");
+    }
+
+    return std::string(data + entry + 4, key_length);
+  }
+
+  std::size_t binary_value::size() const
+  {
+    if (!is_array() && !is_object()) {
+      throw std::runtime_error("Expected array or object in binary document");
+    }
+
+    std::size_t count = read_u32(offset + 1);
+    if (offset + 5 + 4 * count > length) {
+      throw std::runtime_error("Truncated binary document");
+    }
+
+    return count;
+  }
+
+  std::string binary_value::to_string() const
+  {
+    expect(char(binary_tag::STRING), "string");
+
+    uint32_t string_length = read_u32(offset + 1);
+    if (offset + 5 + string_length > length) {
+      throw std::runtime_error("Truncated binary document");
+    }
+
+    return std::string(data + offset + 5, string_length);
+  }
+
+  double binary_value::to_number() const
+  {
+    expect(char(binary_tag::NUMBER), "number");
+
+    if (offset + 9 > length) {
+      throw std::runtime_error("Truncated binary document");
+    }
+
+    uint64_t bits = 0;
+    for (int i = 0; i < 8; i++) {
+      bits |= uint64_t(static_cast<unsigned char>(data[offset + 1 + i])) << (8 * i);
+    }
+
+    double d;
+    std::memcpy(&d, &bits, sizeof(d));
+    return d;
+  }
+
+  bool binary_value::to_bool() const
+  {
+    if (!is_boolean()) {
+      throw std::runtime_error("Expected boolean in binary document");
+    }
+
+    return tag() == char(binary_tag::TRUE);
+  }
+
+  value binary_value::to_value() const
+  {
+    std::size_t end;
+    return to_value(0, end);
+  }
+
+  // sets end to the position just past this node. children have to follow
+  // each other directly after the offset table, so no bytes are shared
+  // between nodes and loading is linear in the document size.
+  value binary_value::to_value(std::size_t depth, std::size_t& end) const
+  {
+    if ((is_array() || is_object()) && depth == max_depth) {
+      throw std::runtime_error("Maximum nesting depth exceeded");
+    }
+
+    if (is_null()) {
+      end = offset + 1;
+      return value();
+    } else if (is_boolean()) {
+      end = offset + 1;
+      return value(to_bool());
+    } else if (is_number()) {
+      end = offset + 9;
+      return value(to_number());
+    } else if (is_string()) {
+      std::string s = to_string();
+      end = offset + 5 + s.size();
+      return value(std::move(s));
+    }
+
+    std::size_t count = size();
+    end = offset + 5 + 4 * count;
+
+    if (is_array()) {
+      std::vector<value> values;
+      values.reserve(count);
+
+      for (std::size_t i = 0; i < count; i++) {
+        expect_child_at(int(i), end);
+        values.push_back(binary_value(data, length, end).to_value(depth + 1, end));
+      }
+
+      return value(std::move(values));
+    } else {
+      std::map<std::string, value> object;
+
+      for (std::size_t i = 0; i < count; i++) {
+        expect_child_at(int(i), end);
+        std::string entry_key = key(int(i));
+        std::size_t value_offset = end + 4 + entry_key.size();
+        object.emplace_hint(object.end(), std::move(entry_key), binary_value(data, length, value_offset).to_value(depth + 1, end));
+      }
+
+      return value(std::move(object));
+    }
+  }
+
+  void binary_value::expect_child_at(int i, std::size_t position) const
+  {
+    if (child(i) != position) {
+      throw std::runtime_error("Invalid offset in binary document");
+    }
+  }
+
+  bool binary_value::is_object() const
+  {
+    return tag() == char(binary_tag::OBJECT);
+  }
+
+  bool binary_value::is_array() const
+  {
+    return tag() == char(binary_tag::ARRAY);
+  }
+
+  bool binary_value::is_string() const
+  {
+    return tag() == char(binary_tag::STRING);
+  }
+
+  bool binary_value::is_number() const
+  {
+    return tag() == char(binary_tag::NUMBER);
+  }
+
+  bool binary_value::is_boolean() const
+  {
+    return tag() == char(binary_tag::TRUE) || tag() == char(binary_tag::FALSE);
+  }
+
+  bool binary_value::is_null() const
+  {
+    return tag() == char(binary_tag::NULL_VALUE);
+  }
+
+  char binary_value::tag() const
+  {
+    if (offset >= length || data[offset] > char(binary_tag::OBJECT) || data[offset] < 0) {
+      throw std::runtime_error("Invalid node in binary document");
+    }
+
+    return data[offset];
+  }
+
+  uint32_t binary_value::read_u32(std::size_t position) const
+  {
+    if (position + 4 > length) {
+      throw std::runtime_error("Truncated binary document");
+    }
+
+    uint32_t n = 0;
+    for (int i = 0; i < 4; i++) {
+      n |= uint32_t(static_cast<unsigned char>(data[position + i])) << (8 * i);
+    }
+
+    return n;
+  }
+
+  // absolute position of the i-th element or entry of this container.
+  // children must start past the offset table, so a node can never point
+  // back at itself or an ancestor.
+  std::size_t binary_value::child(int i) const
+  {
+    std::size_t relative = read_u32(offset + 5 + 4 * std::size_t(i));
+
+    if (relative < 5 + 4 * size() || offset + relative >= length) {
+      throw std::runtime_error("Invalid offset in binary document");
+    }
+
+    return offset + relative;
+  }
+
+  void binary_value::expect(char expected, const char* name) const
+  {
+    if (tag() != expected) {
+      throw std::runtime_error(std::string("Expected ") + name + " in binary document");
+    }
+  }
+
+  // mapped_file impl
+  mapped_file::mapped_file(const std::string& filename) :
+    data(nullptr), size(0)
+  {
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+      throw std::runtime_error(std::string("Could not open: ") + filename);
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+      close(fd);
+      throw std::runtime_error(std::string("Could not stat: ") + filename);
+    }
+
+    size = info.st_size;
+    if (size > 0) {
+      void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (mapped == MAP_FAILED) {
+        close(fd);
+        throw std::runtime_error(std::string("Could not map: ") + filename);
+      }
+
+      data = static_cast<const char*>(mapped);
+    }
+
+    close(fd);
+  }
+
+  mapped_file::~mapped_file()
+  {
+    if (data) {
+      munmap(const_cast<char*>(data), size);
+    }
+  }
+
+  binary_value mapped_file::root() const
+  {
+    return binary_value(data, size);
+  }
+}
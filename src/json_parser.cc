@@ -1,13 +1,26 @@
-#include <deque>
+#include <algorithm>
+#include <bitset>
 #include <stdexcept>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
 
 #include "json_parser.hpp"
 
+// stats impl
+#ifdef JSON_PARSER_STATS
 namespace json_parser {
+  thread_local parse_stats* current_stats = nullptr;
+}
 
-  // token impl
-  enum class token_type { TRUE, FALSE, NULL_TOKEN, STRING, NUMBER, LBRACE, RBRACE, LBRACKET, RBRACKET, COLON, COMMA };
+#define JSON_PARSER_STAT(expr) do { if (json_parser::current_stats) { json_parser::current_stats->expr; } } while (0)
+#else
+#define JSON_PARSER_STAT(expr) do {} while (0)
+#endif
 
+namespace json_parser {
+
+  // token impl
   struct token {
     std::string text;
     token_type type;
@@ -17,23 +30,67 @@ namespace json_parser {
     {}
   };
 
+  // tokens past size are kept around so their text buffers can be reused by
+  // the next parse instead of being freed and allocated again
+  struct token_list {
+    std::vector<token> tokens;
+    std::size_t size = 0;
+    std::size_t position = 0;
+
+    void clear()
+    {
+      size = 0;
+      position = 0;
+    }
+
+    // returns the new token's emptied text buffer
+    std::string& push(token_type type)
+    {
+      if (size == tokens.size()) {
+        tokens.emplace_back(std::string(), type);
+      } else {
+        tokens[size].type = type;
+        tokens[size].text.clear();
+      }
+
+      return tokens[size++].text;
+    }
+
+    bool empty() { return position == size; }
+    token& front() { return tokens[position]; }
+    token& back() { return tokens[size - 1]; }
+    void pop_front() { position++; }
+  };
+
   // tokenize impl
-  std::deque<token> tokenize(std::istream& input);
+  void tokenize(std::istream& input, token_list& tokens);
   std::string read_null(std::istream& input);
   std::string read_false(std::istream& input);
   std::string read_true(std::istream& input);
-  std::string read_number(std::istream& input);
-  std::string read_string(std::istream& input);
-
-  std::deque<token> tokenize(std::istream& input)
+  void read_number(std::istream& input, std::string& accum);
+  void read_string(std::istream& input, std::string& accum);
+
+  // scan impl, shared by tokenize and validate
+  bool is_whitespace(int c);
+  void skip_whitespace(std::istream& input);
+  bool scan_literal(std::istream& input, const char* literal);
+  bool scan_number(std::istream& input, std::string* accum);
+  bool scan_string(std::istream& input);
+  bool scan_unicode_escape(std::istream& input, uint32_t& code_point);
+  bool scan_hex4(std::istream& input, uint32_t& code_point);
+
+  // utf8 impl
+  void append_utf8(std::string& out, uint32_t code_point);
+  bool valid_utf8(const char* data, std::size_t length);
+  std::size_t utf8_complete_prefix(const char* data, std::size_t length);
+  std::size_t utf8_sequence_width(unsigned char lead, unsigned char& lower, unsigned char& upper);
+
+  void tokenize(std::istream& input, token_list& tokens)
   {
     char current;
-    std::deque<token> tokens;
 
     while(true) {
-      while (isspace(input.peek())) {
-        input.get();
-      }
+      skip_whitespace(input);
 
       current = input.get();
 
@@ -43,46 +100,46 @@ namespace json_parser {
 
       switch(current) {
       case '{':
-        tokens.emplace_back(std::string(1, current), token_type::LBRACKET);
+        tokens.push(token_type::LBRACE) += current;
         break;
       case '}':
-        tokens.emplace_back(std::string(1, current), token_type::RBRACKET);
+        tokens.push(token_type::RBRACE) += current;
         break;
       case '[':
-        tokens.emplace_back(std::string(1, current), token_type::LBRACE);
+        tokens.push(token_type::LBRACKET) += current;
         break;
       case ']':
-        tokens.emplace_back(std::string(1, current), token_type::RBRACE);
+        tokens.push(token_type::RBRACKET) += current;
         break;
       case ':':
-        tokens.emplace_back(std::string(1, current), token_type::COLON);
+        tokens.push(token_type::COLON) += current;
         break;
       case ',':
-        tokens.emplace_back(std::string(1, current), token_type::COMMA);
+        tokens.push(token_type::COMMA) += current;
         break;
       case '"':
-        tokens.emplace_back(read_string(input), token_type::STRING);
+        read_string(input, tokens.push(token_type::STRING));
         break;
       case 't':
         input.unget();
-        tokens.emplace_back(read_true(input), token_type::TRUE);
+        tokens.push(token_type::TRUE) = read_true(input);
         break;
       case 'f':
         input.unget();
-        tokens.emplace_back(read_false(input), token_type::FALSE);
+        tokens.push(token_type::FALSE) = read_false(input);
         break;
       case 'n':
         input.unget();
-        tokens.emplace_back(read_null(input), token_type::NULL_TOKEN);
+        tokens.push(token_type::NULL_TOKEN) = read_null(input);
         break;
       default:
         input.unget();
-        tokens.emplace_back(read_number(input), token_type::NUMBER);
+        read_number(input, tokens.push(token_type::NUMBER));
         break;
       }
-    }
 
-    return tokens;
+      JSON_PARSER_STAT(tokens_by_type[std::size_t(tokens.back().type)]++);
+    }
   }
   
   std::string read_null(std::istream& input)
@@ -121,107 +178,386 @@ namespace json_parser {
     return "true";
   }
 
-  std::string read_number(std::istream& input)
+  void read_number(std::istream& input, std::string& accum)
   {
-    std::string accum;
-    char first = input.get();
+    if (!scan_number(input, &accum)) {
+      throw std::runtime_error(std::string("Invalid number: ") + accum + char(input.peek()));
+    }
+  }
 
-    if (first == '-' || (isdigit(first))) {
-      accum += first;
-    } else {
-      throw std::runtime_error(std::string("Expected number, got: ") + char(first));
+  void read_string(std::istream& input, std::string& accum)
+  {
+    int current;
+
+    while((current = input.get()) != EOF) {
+      if (current == '"') {
+        // escapes only ever emit complete sequences starting with an ASCII or
+        // lead byte, so checking the whole accumulated string covers the raw bytes
+        if (!valid_utf8(accum.data(), accum.size())) {
+          throw std::runtime_error("Invalid UTF-8 in string");
+        }
+
+        JSON_PARSER_STAT(strings_decoded++);
+        return;
+      }
+
+      if (current < 0x20) {
+        throw std::runtime_error(std::string("Unescaped control character in string: ") + std::to_string(current));
+      }
+
+      if (current != '\\') {
+        accum += char(current);
+        continue;
+      }
+
+      JSON_PARSER_STAT(escapes_decoded++);
+
+      int escaped = input.get();
+      uint32_t code_point;
+      switch(escaped) {
+      case '"':
+        accum += '"';
+        break;
+      case '\\':
+        accum += '\\';
+        break;
+      case '/':
+        accum += '/';
+        break;
+      case 'b':
+        accum += '\b';
+        break;
+      case 'f':
+        accum += '\f';
+        break;
+      case 'n':
+        accum += '\n';
+        break;
+      case 'r':
+        accum += '\r';
+        break;
+      case 't':
+        accum += '\t';
+        break;
+      case 'u':
+        if (!scan_unicode_escape(input, code_point)) {
+          throw std::runtime_error("Invalid unicode escape");
+        }
+        append_utf8(accum, code_point);
+        break;
+      case EOF:
+        throw std::runtime_error(std::string("Unexpected EOF"));
+      default:
+        throw std::runtime_error(std::string("Unexpected character in escape sequence: ") + char(escaped));
+      }
     }
 
-    if (accum  == "0") {
-      if (isdigit(input.peek())) {
-        throw std::runtime_error("Invalid leading zero");      
+    throw std::runtime_error(std::string("Unexpected EOF"));
+  }
+
+  // scan impl
+  bool is_whitespace(int c)
+  {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+  }
+
+  void skip_whitespace(std::istream& input)
+  {
+    while (is_whitespace(input.peek())) {
+      input.get();
+    }
+  }
+
+  bool scan_literal(std::istream& input, const char* literal)
+  {
+    for (; *literal; literal++) {
+      if (input.get() != *literal) {
+        return false;
       }
-    } else {
-      while (isdigit(input.peek())) {
-        accum += input.get();
+    }
+
+    return true;
+  }
+
+  // appends the consumed characters to accum unless it is null
+  bool scan_number(std::istream& input, std::string* accum)
+  {
+    auto take = [&]() {
+      char c = input.get();
+      if (accum) {
+        *accum += c;
       }
+    };
+
+    if (input.peek() == '-') {
+      take();
     }
 
-    if (input.peek() != '.') {
-      return accum;
+    if (input.peek() == '0') {
+      take();
+    } else if (isdigit(input.peek())) {
+      while (isdigit(input.peek())) {
+        take();
+      }
     } else {
-      accum += input.get();
+      return false;
     }
 
-    while (isdigit(input.peek())) {
-      accum += input.get();
+    if (input.peek() == '.') {
+      take();
+
+      if (!isdigit(input.peek())) {
+        return false;
+      }
+
+      while (isdigit(input.peek())) {
+        take();
+      }
     }
 
     if ((input.peek() == 'e') || (input.peek() == 'E')) {
-      accum += input.get();
+      take();
 
       if ((input.peek() == '+') || (input.peek() == '-')) {
-        accum += input.get();
+        take();
       }
 
+      if (!isdigit(input.peek())) {
+        return false;
+      }
+
+      while (isdigit(input.peek())) {
+        take();
+      }
     }
 
-    if (!isdigit(input.peek())) {
-      throw std::runtime_error(std::string("Expected digit, got: ") + char(input.get()));
+    return true;
+  }
+
+  // same checks as read_string without keeping the contents. raw bytes are
+  // collected in a fixed buffer and checked with valid_utf8 a chunk at a time.
+  bool scan_string(std::istream& input)
+  {
+    char buffer[256];
+    std::size_t size = 0;
+    int current;
+    uint32_t code_point;
+
+    while((current = input.get()) != EOF) {
+      if (current == '"') {
+        return valid_utf8(buffer, size);
+      }
+
+      if (current < 0x20) {
+        return false;
+      }
+
+      if (current != '\\') {
+        if (size == sizeof(buffer)) {
+          // keep a sequence cut off by the end of the buffer for the next chunk
+          std::size_t complete = utf8_complete_prefix(buffer, size);
+          if (!valid_utf8(buffer, complete)) {
+            return false;
+          }
+
+          std::memmove(buffer, buffer + complete, size - complete);
+          size -= complete;
+        }
+
+        buffer[size++] = char(current);
+        continue;
+      }
+
+      // an escape can't continue a raw sequence, so the bytes so far must be complete
+      if (!valid_utf8(buffer, size)) {
+        return false;
+      }
+      size = 0;
+
+      switch(input.get()) {
+      case '"':
+      case '\\':
+      case '/':
+      case 'b':
+      case 'f':
+      case 'n':
+      case 'r':
+      case 't':
+        break;
+      case 'u':
+        if (!scan_unicode_escape(input, code_point)) {
+          return false;
+        }
+        break;
+      default:
+        return false;
+      }
     }
 
-    while (isdigit(input.peek())) {
-      accum += input.get();
+    return false;
+  }
+
+  // expects the leading \u to be consumed, rejects unpaired surrogates
+  bool scan_unicode_escape(std::istream& input, uint32_t& code_point)
+  {
+    if (!scan_hex4(input, code_point)) {
+      return false;
     }
 
-    return accum;
+    if (code_point >= 0xDC00 && code_point <= 0xDFFF) {
+      return false;
+    }
+
+    if (code_point < 0xD800 || code_point > 0xDBFF) {
+      return true;
+    }
+
+    uint32_t low;
+    if (input.get() != '\\' || input.get() != 'u' || !scan_hex4(input, low)) {
+      return false;
+    }
+
+    if (low < 0xDC00 || low > 0xDFFF) {
+      return false;
+    }
+
+    code_point = 0x10000 + ((code_point - 0xD800) << 10) + (low - 0xDC00);
+    return true;
   }
 
-  std::string read_string(std::istream& input)
+  bool scan_hex4(std::istream& input, uint32_t& code_point)
   {
-    std::string accum;
-    char current;
+    code_point = 0;
+
+    for (int i = 0; i < 4; i++) {
+      int digit = input.get();
+      code_point <<= 4;
+
+      if (digit >= '0' && digit <= '9') {
+        code_point |= digit - '0';
+      } else if (digit >= 'a' && digit <= 'f') {
+        code_point |= digit - 'a' + 10;
+      } else if (digit >= 'A' && digit <= 'F') {
+        code_point |= digit - 'A' + 10;
+      } else {
+        return false;
+      }
+    }
 
-    while(input.good()) {
-      current = input.get();
+    return true;
+  }
 
-      if (current == '\\') {
-        char escaped = input.get();
-        switch(escaped) {
-        case '"': 
-          current = '"';
-          break;
-        case '\\':
-          current = '\\';
-          break;
-        case '/':
-          current = '/';
-          break;
-        case 'b':
-          current = '\b';
-          break;
-        case 'f':
-          current = '\f';
-          break;
-        case 'n':
-          current = '\n';
-          break;
-        case 'r':
-          current = '\r';
-          break;
-        case 't':
-          current = '\t';
-          break;
-        case 'u':
-          throw std::runtime_error("Unicode not supported");  
-        default:
-          throw std::runtime_error(std::string("Unexpected character in escape sequence: ") + escaped);  
+  // utf8 impl
+  void append_utf8(std::string& out, uint32_t code_point)
+  {
+    if (code_point < 0x80) {
+      out += char(code_point);
+    } else if (code_point < 0x800) {
+      out += char(0xC0 | (code_point >> 6));
+      out += char(0x80 | (code_point & 0x3F));
+    } else if (code_point < 0x10000) {
+      out += char(0xE0 | (code_point >> 12));
+      out += char(0x80 | ((code_point >> 6) & 0x3F));
+      out += char(0x80 | (code_point & 0x3F));
+    } else {
+      out += char(0xF0 | (code_point >> 18));
+      out += char(0x80 | ((code_point >> 12) & 0x3F));
+      out += char(0x80 | ((code_point >> 6) & 0x3F));
+      out += char(0x80 | (code_point & 0x3F));
+    }
+  }
+
+  bool valid_utf8(const char* data, std::size_t length)
+  {
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+    const uint64_t high_bits = 0x8080808080808080ULL;
+    std::size_t i = 0;
+
+    while (i < length) {
+      // ascii fast path, 16 bytes per step
+      if (i + 16 <= length) {
+        uint64_t first, second;
+        std::memcpy(&first, bytes + i, 8);
+        std::memcpy(&second, bytes + i + 8, 8);
+
+        if (((first | second) & high_bits) == 0) {
+          i += 16;
+          continue;
         }
       }
-    
-      if (current == '"') {
-        return accum;
+
+      unsigned char lead = bytes[i];
+      if (lead < 0x80) {
+        i++;
+        continue;
       }
 
-      accum += current;
+      unsigned char lower, upper;
+      std::size_t width = utf8_sequence_width(lead, lower, upper);
+
+      if (width == 0 || i + width > length) {
+        return false;
+      }
+
+      if (bytes[i + 1] < lower || bytes[i + 1] > upper) {
+        return false;
+      }
+
+      for (std::size_t j = 2; j < width; j++) {
+        if (bytes[i + j] < 0x80 || bytes[i + j] > 0xBF) {
+          return false;
+        }
+      }
+
+      i += width;
+    }
+
+    return true;
+  }
+
+  // length of data without a trailing sequence that could be completed by
+  // bytes past the end
+  std::size_t utf8_complete_prefix(const char* data, std::size_t length)
+  {
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+
+    for (std::size_t back = 1; back <= 3 && back <= length; back++) {
+      unsigned char byte = bytes[length - back];
+
+      if (byte < 0x80) {
+        return length;
+      }
+
+      if (byte >= 0xC0) {
+        unsigned char lower, upper;
+        std::size_t width = utf8_sequence_width(byte, lower, upper);
+        return width > back ? length - back : length;
+      }
     }
 
-    throw std::runtime_error(std::string("Unexpected EOF"));  
+    return length;
+  }
+
+  // ranges from table 3-7 of the unicode standard, returns 0 for bytes that
+  // cannot start a sequence
+  std::size_t utf8_sequence_width(unsigned char lead, unsigned char& lower, unsigned char& upper)
+  {
+    lower = 0x80;
+    upper = 0xBF;
+
+    if (lead >= 0xC2 && lead <= 0xDF) {
+      return 2;
+    } else if (lead >= 0xE0 && lead <= 0xEF) {
+      if (lead == 0xE0) lower = 0xA0;
+      if (lead == 0xED) upper = 0x9F;
+      return 3;
+    } else if (lead >= 0xF0 && lead <= 0xF4) {
+      if (lead == 0xF0) lower = 0x90;
+      if (lead == 0xF4) upper = 0x8F;
+      return 4;
+    }
+
+    return 0;
   }
 
 
@@ -282,96 +618,352 @@ namespace json_parser {
   }
 
   // parse_json impl
-  value parse_value(std::deque<token>& tokens);
-  std::vector<value> read_array(std::deque<token>& tokens);
-  std::map<std::string, value> read_object(std::deque<token>& tokens);
+  void parse_document(token_list& tokens, value& out);
+  token& next_token(token_list& tokens);
+
+  // builds values in place, reusing whatever containers and strings the
+  // target already holds from a previous parse
+  class value_builder {
+  public:
+    static void parse_value(token_list& tokens, std::size_t depth, value& out);
+
+  private:
+    static void read_array(token_list& tokens, std::size_t depth, std::vector<value>& values);
+    static void read_object(token_list& tokens, std::size_t depth, std::map<std::string, value>& object);
+
+    // returns out's T, replacing its contents with an empty T if it holds another type
+    template <typename T>
+    static T& reuse_as(value& out)
+    {
+      if (T* existing = boost::get<T>(&out.data)) {
+        return *existing;
+      }
+
+      out.data = T();
+      return boost::get<T>(out.data);
+    }
+  };
 
   value parse(std::istream& input)
   {
-    auto tokens = tokenize(input);
-    return parse_value(tokens);
+    return parser().parse(input);
   }
 
-  value parse_value(std::deque<token>& tokens)
+  parser::parser() : tokens(new token_list()) {}
+  parser::parser(parser&&) = default;
+  parser& parser::operator=(parser&&) = default;
+  parser::~parser() = default;
+
+  // a moved-from parser has no token list, so it is created here on demand
+  token_list& parser::reset_tokens()
   {
-    auto tok = tokens.front();
+    if (!tokens) {
+      tokens.reset(new token_list());
+    }
+
+    tokens->clear();
+    return *tokens;
+  }
+
+  value parser::parse(std::istream& input)
+  {
+    value result;
+    parse(input, result);
+    return result;
+  }
+
+  void parser::parse(std::istream& input, value& out)
+  {
+    tokenize(input, reset_tokens());
+    parse_document(*tokens, out);
+  }
+
+#ifdef JSON_PARSER_STATS
+  value parse(std::istream& input, parse_stats& stats)
+  {
+    return parser().parse(input, stats);
+  }
+
+  value parser::parse(std::istream& input, parse_stats& stats)
+  {
+    value result;
+    parse(input, result, stats);
+    return result;
+  }
+
+  void parser::parse(std::istream& input, value& out, parse_stats& stats)
+  {
+    using clock = std::chrono::steady_clock;
+
+    // restores the previous stats target even if parsing throws
+    struct stats_scope {
+      parse_stats* previous;
+      stats_scope(parse_stats& stats) : previous(current_stats) { current_stats = &stats; }
+      ~stats_scope() { current_stats = previous; }
+    } scope(stats);
+
+    stats = parse_stats();
+    std::streamoff start = input.tellg();
+
+    auto lex_start = clock::now();
+    tokenize(input, reset_tokens());
+    auto build_start = clock::now();
+    stats.lex_time = build_start - lex_start;
+
+    auto state = input.rdstate();
+    input.clear();
+    std::streamoff end = input.tellg();
+    input.setstate(state);
+    if (start >= 0 && end >= start) {
+      stats.bytes_consumed = end - start;
+    }
+
+    parse_document(*tokens, out);
+    stats.build_time = clock::now() - build_start;
+  }
+#endif
+
+  void parse_document(token_list& tokens, value& out)
+  {
+    value_builder::parse_value(tokens, 0, out);
+
+    if (!tokens.empty()) {
+      throw std::runtime_error(std::string("Unexpected trailing token: ") + tokens.front().text);
+    }
+  }
+
+  token& next_token(token_list& tokens)
+  {
+    if (tokens.empty()) {
+      throw std::runtime_error(std::string("Unexpected EOF"));
+    }
+
+    return tokens.front();
+  }
+
+  void value_builder::parse_value(token_list& tokens, std::size_t depth, value& out)
+  {
+    token& tok = next_token(tokens);
     tokens.pop_front();
-    
+
+    if (tok.type == token_type::LBRACE || tok.type == token_type::LBRACKET) {
+      if (depth == max_depth) {
+        throw std::runtime_error(std::string("Maximum nesting depth exceeded"));
+      }
+
+      JSON_PARSER_STAT(max_depth = std::max(current_stats->max_depth, depth + 1));
+    }
+
     switch(tok.type) {
-    case token_type::LBRACKET :
-      return value(read_object(tokens));
     case token_type::LBRACE :
-      return value(read_array(tokens));
+      read_object(tokens, depth + 1, reuse_as<std::map<std::string, value>>(out));
+      break;
+    case token_type::LBRACKET :
+      read_array(tokens, depth + 1, reuse_as<std::vector<value>>(out));
+      break;
     case token_type::STRING :
-      return value(tok.text);
+      reuse_as<std::string>(out).assign(tok.text);
+      break;
     case token_type::NUMBER :
-      return value(std::stod(tok.text));
+      JSON_PARSER_STAT(numbers_parsed++);
+      // strtod rounds numbers outside double range to +-HUGE_VAL or zero
+      // instead of failing, so parse accepts everything validate does
+      out.data = std::strtod(tok.text.c_str(), nullptr);
+      break;
     case token_type::TRUE :
-      return value(true);
+      out.data = true;
+      break;
     case token_type::FALSE :
-      return value(false);
+      out.data = false;
+      break;
     case token_type::NULL_TOKEN :
-      return value();
+      out.data = boost::none;
+      break;
     default:
       throw std::runtime_error(std::string("Invalid token, expected value, got: ") +  tok.text);
     }
   }
 
-  std::vector<value> read_array(std::deque<token>& tokens)
+  // elements past the new size are dropped, the vector keeps its capacity
+  void value_builder::read_array(token_list& tokens, std::size_t depth, std::vector<value>& values)
   {
-    std::vector<value> values;
+    std::size_t size = 0;
 
-    while(tokens.front().type != token_type::RBRACE) {
-      values.push_back(parse_value(tokens));
+    if (next_token(tokens).type == token_type::RBRACKET) {
+      tokens.pop_front();
+      values.clear();
+      return;
+    }
 
-      if (tokens.front().type == token_type::RBRACE) {
-        continue;
+    while(true) {
+      if (size == values.size()) {
+        values.emplace_back();
       }
-    
-      token comma = tokens.front();
+      parse_value(tokens, depth, values[size++]);
+
+      token& comma = next_token(tokens);
+      tokens.pop_front();
+
+      if (comma.type == token_type::RBRACKET) {
+        values.erase(values.begin() + size, values.end());
+        return;
+      }
+
       if (comma.type != token_type::COMMA) {
         throw std::runtime_error(std::string("Invalid token, expected comma, got: ") + comma.text);
       }
-      tokens.pop_front();
     }
-
-    tokens.pop_front();
-    return values;
   }
 
-  std::map<std::string, value> read_object(std::deque<token>& tokens)
+  // nodes for keys seen last time are moved over with their values, so
+  // same-shaped objects don't allocate
+  void value_builder::read_object(token_list& tokens, std::size_t depth, std::map<std::string, value>& object)
   {
-    std::map<std::string, value> object;
+    std::map<std::string, value> previous;
+    previous.swap(object);
+
+    if (next_token(tokens).type == token_type::RBRACE) {
+      tokens.pop_front();
+      return;
+    }
 
-    while(tokens.front().type != token_type::RBRACKET) {
-      token key = tokens.front();
+    while(true) {
+      token& key = next_token(tokens);
       if (key.type != token_type::STRING) {
         throw std::runtime_error(std::string("Invalid token, expected string, got: ") +  key.text);
       }
       tokens.pop_front();
 
-      token colon = tokens.front();
+      token& colon = next_token(tokens);
       if (colon.type != token_type::COLON) {
         throw std::runtime_error(std::string("Invalid token, expected colon, got: ") + colon.text);
       }
       tokens.pop_front();
 
-      value v = parse_value(tokens);
+      // a repeated key finds the existing entry, so the last one wins
+      auto node = previous.extract(key.text);
+      value& v = node.empty() ? object[key.text] : object.insert(std::move(node)).position->second;
+      parse_value(tokens, depth, v);
 
-      object[key.text] = v;
+      token& comma = next_token(tokens);
+      tokens.pop_front();
 
-      if (tokens.front().type == token_type::RBRACKET) {
-        continue;
+      if (comma.type == token_type::RBRACE) {
+        return;
       }
 
-      token comma = tokens.front();
       if (comma.type != token_type::COMMA) {
         throw std::runtime_error(std::string("Invalid token, expected comma, got: ") + comma.text);
       }
-      tokens.pop_front();
     }
+  }
 
-    tokens.pop_front();
-    return object;
+  // validate impl
+  bool scan_key(std::istream& input);
+
+  bool validate(std::istream& input)
+  {
+    // one bit per open container, set for objects
+    std::bitset<max_depth> objects;
+    std::size_t depth = 0;
+
+    while(true) {
+      skip_whitespace(input);
+      int current = input.get();
+
+      switch(current) {
+      case '{':
+        if (depth == max_depth) {
+          return false;
+        }
+        objects[depth++] = true;
+
+        skip_whitespace(input);
+        if (input.peek() == '}') {
+          input.get();
+          depth--;
+          break;
+        }
+
+        if (!scan_key(input)) {
+          return false;
+        }
+        continue;
+      case '[':
+        if (depth == max_depth) {
+          return false;
+        }
+        objects[depth++] = false;
+
+        skip_whitespace(input);
+        if (input.peek() == ']') {
+          input.get();
+          depth--;
+          break;
+        }
+        continue;
+      case '"':
+        if (!scan_string(input)) {
+          return false;
+        }
+        break;
+      case 't':
+        if (!scan_literal(input, "rue")) {
+          return false;
+        }
+        break;
+      case 'f':
+        if (!scan_literal(input, "alse")) {
+          return false;
+        }
+        break;
+      case 'n':
+        if (!scan_literal(input, "ull")) {
+          return false;
+        }
+        break;
+      case EOF:
+        return false;
+      default:
+        input.unget();
+        if (!scan_number(input, nullptr)) {
+          return false;
+        }
+        break;
+      }
+
+      // a value is complete, close containers until another value is expected
+      while(true) {
+        skip_whitespace(input);
+        current = input.get();
+
+        if (depth == 0) {
+          return current == EOF;
+        }
+
+        if (current == ',') {
+          if (objects[depth - 1] && !scan_key(input)) {
+            return false;
+          }
+          break;
+        }
+
+        if (current != (objects[depth - 1] ? '}' : ']')) {
+          return false;
+        }
+        depth--;
+      }
+    }
+  }
+
+  bool scan_key(std::istream& input)
+  {
+    skip_whitespace(input);
+    if (input.get() != '"' || !scan_string(input)) {
+      return false;
+    }
+
+    skip_whitespace(input);
+    return input.get() == ':';
   }
 }
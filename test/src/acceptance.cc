@@ -113,6 +113,9 @@ TEST_CASE("acceptance tests") {
       CAPTURE(filename); 
       std::ifstream input(filename);
       CHECK_NOTHROW(json_parser::parse(input));
+
+      std::ifstream validate_input(filename);
+      CHECK(json_parser::validate(validate_input));
     }
   }
 
@@ -314,6 +317,63 @@ TEST_CASE("acceptance tests") {
       CAPTURE(filename); 
       std::ifstream input(filename);
       CHECK_THROWS(json_parser::parse(input));
+
+      std::ifstream validate_input(filename);
+      CHECK_FALSE(json_parser::validate(validate_input));
+    }
+  }
+  SUBCASE("implementation defined json") {
+    std::vector<std::string> filenames = {
+      "test/data/acceptance/i_number_double_huge_neg_exp.json",
+      "test/data/acceptance/i_number_huge_exp.json",
+      "test/data/acceptance/i_number_neg_int_huge_exp.json",
+      "test/data/acceptance/i_number_pos_double_huge_exp.json",
+      "test/data/acceptance/i_number_real_neg_overflow.json",
+      "test/data/acceptance/i_number_real_pos_overflow.json",
+      "test/data/acceptance/i_number_real_underflow.json",
+      "test/data/acceptance/i_number_too_big_neg_int.json",
+      "test/data/acceptance/i_number_too_big_pos_int.json",
+      "test/data/acceptance/i_number_very_big_negative_int.json",
+      "test/data/acceptance/i_object_key_lone_2nd_surrogate.json",
+      "test/data/acceptance/i_string_1st_surrogate_but_2nd_missing.json",
+      "test/data/acceptance/i_string_1st_valid_surrogate_2nd_invalid.json",
+      "test/data/acceptance/i_string_UTF-16LE_with_BOM.json",
+      "test/data/acceptance/i_string_UTF-8_invalid_sequence.json",
+      "test/data/acceptance/i_string_UTF8_surrogate_U+D800.json",
+      "test/data/acceptance/i_string_incomplete_surrogate_and_escape_valid.json",
+      "test/data/acceptance/i_string_incomplete_surrogate_pair.json",
+      "test/data/acceptance/i_string_incomplete_surrogates_escape_valid.json",
+      "test/data/acceptance/i_string_invalid_lonely_surrogate.json",
+      "test/data/acceptance/i_string_invalid_surrogate.json",
+      "test/data/acceptance/i_string_invalid_utf-8.json",
+      "test/data/acceptance/i_string_inverted_surrogates_U+1D11E.json",
+      "test/data/acceptance/i_string_iso_latin_1.json",
+      "test/data/acceptance/i_string_lone_second_surrogate.json",
+      "test/data/acceptance/i_string_lone_utf8_continuation_byte.json",
+      "test/data/acceptance/i_string_not_in_unicode_range.json",
+      "test/data/acceptance/i_string_overlong_sequence_2_bytes.json",
+      "test/data/acceptance/i_string_overlong_sequence_6_bytes.json",
+      "test/data/acceptance/i_string_overlong_sequence_6_bytes_null.json",
+      "test/data/acceptance/i_string_truncated-utf-8.json",
+      "test/data/acceptance/i_string_utf16BE_no_BOM.json",
+      "test/data/acceptance/i_string_utf16LE_no_BOM.json",
+      "test/data/acceptance/i_structure_500_nested_arrays.json",
+      "test/data/acceptance/i_structure_UTF-8_BOM_empty_object.json"
+    };
+
+    // either outcome is allowed, but validate has to predict parse
+    for (auto filename : filenames) {
+      CAPTURE(filename);
+      std::ifstream input(filename);
+      bool parsed = true;
+      try {
+        json_parser::parse(input);
+      } catch (std::exception&) {
+        parsed = false;
+      }
+
+      std::ifstream validate_input(filename);
+      CHECK(json_parser::validate(validate_input) == parsed);
     }
   }
 }
@@ -0,0 +1,127 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest.h>
+
+#include <json_parser.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+std::string to_binary(json_parser::value v)
+{
+  std::ostringstream output;
+  json_parser::write_binary(v, output);
+  return output.str();
+}
+
+TEST_CASE("binary round trip") {
+  for (auto& entry : std::filesystem::directory_iterator("test/data/acceptance")) {
+    std::string filename = entry.path().string();
+    if (entry.path().filename().string().rfind("y_", 0) != 0) {
+      continue;
+    }
+
+    CAPTURE(filename);
+    std::ifstream input(filename);
+    json_parser::value parsed = json_parser::parse(input);
+
+    std::string binary = to_binary(parsed);
+    json_parser::value loaded = json_parser::read_binary(binary.data(), binary.size());
+
+    CHECK(to_binary(loaded) == binary);
+  }
+}
+
+TEST_CASE("binary in place access") {
+  std::istringstream input("{\"b\": [1.5, \"two\", null], \"a\": {\"x\": true}, \"c\": false}");
+  std::string binary = to_binary(json_parser::parse(input));
+  json_parser::binary_value root(binary.data(), binary.size());
+
+  REQUIRE(root.is_object());
+  CHECK(root.size() == 3);
+  CHECK(root.key(0) == "a");
+  CHECK(root.at("a").at("x").to_bool());
+  CHECK_FALSE(root.at("c").to_bool());
+  CHECK(root.at("b").at(0).to_number() == 1.5);
+  CHECK(root.at("b").at(1).to_string() == "two");
+  CHECK(root.at("b").at(2).is_null());
+  CHECK_THROWS(root.at("d"));
+  CHECK_THROWS(root.at("b").at(3));
+  CHECK_THROWS(root.at("b").to_string());
+  CHECK_THROWS(root.at("b").at(2).to_bool());
+}
+
+TEST_CASE("binary truncated") {
+  std::istringstream input("[\"a string\", 1, 2]");
+  std::string binary = to_binary(json_parser::parse(input));
+
+  for (std::size_t size = 0; size < binary.size(); size++) {
+    CAPTURE(size);
+    CHECK_THROWS(json_parser::read_binary(binary.data(), size));
+  }
+}
+
+TEST_CASE("binary corrupt offsets") {
+  // an array whose only element points back at the array itself
+  std::string self_reference("JPB1\x05\x01\x00\x00\x00\x00\x00\x00\x00", 13);
+  CHECK_THROWS(json_parser::read_binary(self_reference.data(), self_reference.size()));
+
+  // an element offset past the end of the document
+  std::string past_end("JPB1\x05\x01\x00\x00\x00\x40\x00\x00\x00\x00", 14);
+  CHECK_THROWS(json_parser::read_binary(past_end.data(), past_end.size()));
+
+  // siblings sharing one subtree, which would take exponential time to load
+  std::string shared("JPB1");
+  for (int i = 0; i < 40; i++) {
+    shared += std::string("\x05\x02\x00\x00\x00\x0d\x00\x00\x00\x0d\x00\x00\x00", 13);
+  }
+  shared += '\x00';
+  CHECK_THROWS(json_parser::read_binary(shared.data(), shared.size()));
+
+  // an element that starts after a gap instead of right after the table
+  std::string gap("JPB1\x05\x01\x00\x00\x00\x0a\x00\x00\x00\x00\x00", 15);
+  CHECK_THROWS(json_parser::read_binary(gap.data(), gap.size()));
+
+  // a count whose offset table doesn't fit in the document
+  std::string huge_count("JPB1\x05\xff\xff\xff\xff", 9);
+  CHECK_THROWS(json_parser::read_binary(huge_count.data(), huge_count.size()));
+}
+
+TEST_CASE("binary nesting limit") {
+  // each level is an array with one element starting right after its table
+  auto nested = [](std::size_t depth) {
+    std::string binary("JPB1");
+    for (std::size_t i = 0; i < depth; i++) {
+      binary += std::string("\x05\x01\x00\x00\x00\x09\x00\x00\x00", 9);
+    }
+    binary += '\x00';
+    return binary;
+  };
+
+  std::string deepest = nested(json_parser::max_depth);
+  CHECK_NOTHROW(json_parser::read_binary(deepest.data(), deepest.size()));
+
+  std::string too_deep = nested(json_parser::max_depth + 1);
+  CHECK_THROWS(json_parser::read_binary(too_deep.data(), too_deep.size()));
+}
+
+TEST_CASE("binary mapped file") {
+  std::string filename = (std::filesystem::temp_directory_path() / "json_parser_binary_test.jpb").string();
+
+  std::ifstream input("test/data/simple.json");
+  json_parser::value parsed = json_parser::parse(input);
+  std::string binary = to_binary(parsed);
+
+  {
+    std::ofstream output(filename, std::ios::binary);
+    json_parser::write_binary(parsed, output);
+  }
+
+  {
+    json_parser::mapped_file mapped(filename);
+    CHECK(to_binary(mapped.root().to_value()) == binary);
+  }
+
+  std::filesystem::remove(filename);
+}
@@ -4,9 +4,117 @@
 #include <json_parser.hpp>
 
 #include <fstream>
+#include <limits>
+#include <sstream>
 
 TEST_CASE("simple example test") {
   std::ifstream input("test/data/simple.json");
   
   REQUIRE_NOTHROW(json_parser::parse(input));
 }
+
+TEST_CASE("unicode escapes") {
+  std::istringstream input("[\"a\\u00e9\\u4e2d\\ud834\\udd1e\", \"0123456789abcdef\xc3\xa9 0123456789abcdef\"]");
+  auto doc = json_parser::parse(input);
+
+  CHECK(doc.at(0).to_string() == "a\xc3\xa9\xe4\xb8\xad\xf0\x9d\x84\x9e");
+  CHECK(doc.at(1).to_string() == "0123456789abcdef\xc3\xa9 0123456789abcdef");
+}
+
+TEST_CASE("invalid utf-8") {
+  std::istringstream input("\"0123456789abcdef0123456789\xc0\xaf\"");
+
+  CHECK_THROWS(json_parser::parse(input));
+}
+
+TEST_CASE("numbers outside double range") {
+  std::istringstream validate_input("[1e400, -1e400, 123.456e-789]");
+  CHECK(json_parser::validate(validate_input));
+
+  std::istringstream input("[1e400, -1e400, 123.456e-789]");
+  auto doc = json_parser::parse(input);
+
+  CHECK(doc.at(0).to_number() == std::numeric_limits<double>::infinity());
+  CHECK(doc.at(1).to_number() == -std::numeric_limits<double>::infinity());
+  CHECK(doc.at(2).to_number() == 0);
+}
+
+TEST_CASE("validate utf-8 across chunks") {
+  // sequences that straddle the scanner's 256 byte buffer
+  for (int padding = 250; padding < 262; padding++) {
+    CAPTURE(padding);
+    std::istringstream valid("\"" + std::string(padding, 'a') + "\xf0\x9d\x84\x9e\"");
+    std::istringstream truncated("\"" + std::string(padding, 'a') + "\xf0\x9d\x84\"");
+
+    CHECK(json_parser::validate(valid));
+    CHECK_FALSE(json_parser::validate(truncated));
+  }
+}
+
+TEST_CASE("reused parser") {
+  json_parser::parser parser;
+
+  std::istringstream first("[\"a string long enough to need a heap buffer\", 1]");
+  CHECK(parser.parse(first).at(0).to_string() == "a string long enough to need a heap buffer");
+
+  std::istringstream invalid("[1, 2");
+  CHECK_THROWS(parser.parse(invalid));
+
+  std::istringstream second("{\"b\": true}");
+  CHECK(parser.parse(second).at("b").to_bool());
+}
+
+TEST_CASE("moved-from parser") {
+  json_parser::parser parser;
+  json_parser::parser other(std::move(parser));
+
+  std::istringstream input("[1]");
+  CHECK(parser.parse(input).at(0).to_number() == 1);
+}
+
+TEST_CASE("parse into a reused value") {
+  json_parser::parser parser;
+  json_parser::value doc;
+
+  std::istringstream first("{\"a\": [1, 2, 3], \"b\": \"text\", \"c\": {\"d\": null}}");
+  parser.parse(first, doc);
+
+  std::istringstream second("{\"a\": [4], \"b\": 5, \"e\": \"new\", \"e\": \"last\"}");
+  parser.parse(second, doc);
+
+  CHECK(doc.at("a").at(0).to_number() == 4);
+  CHECK_THROWS(doc.at("a").at(1));
+  CHECK(doc.at("b").to_number() == 5);
+  CHECK_THROWS(doc.at("c"));
+  CHECK(doc.at("e").to_string() == "last");
+
+  std::istringstream third("[true]");
+  parser.parse(third, doc);
+
+  REQUIRE(doc.is_array());
+  CHECK(doc.at(0).to_bool());
+}
+
+#ifdef JSON_PARSER_STATS
+TEST_CASE("parse stats") {
+  std::istringstream input("{\"a\": [1, 2.5, \"x\\ty\"], \"b\": null}");
+  json_parser::parse_stats stats;
+  json_parser::parse(input, stats);
+
+  CHECK(stats.bytes_consumed == input.str().size());
+  CHECK(stats.tokens_by_type[std::size_t(json_parser::token_type::NUMBER)] == 2);
+  CHECK(stats.tokens_by_type[std::size_t(json_parser::token_type::COMMA)] == 3);
+  CHECK(stats.strings_decoded == 3);
+  CHECK(stats.escapes_decoded == 1);
+  CHECK(stats.numbers_parsed == 2);
+  CHECK(stats.max_depth == 2);
+  CHECK(stats.allocations > 0);
+  CHECK(stats.bytes_allocated > 0);
+
+  std::istringstream brackets("[[], [], {}]");
+  json_parser::parse(brackets, stats);
+
+  CHECK(stats.tokens_by_type[std::size_t(json_parser::token_type::LBRACKET)] == 3);
+  CHECK(stats.tokens_by_type[std::size_t(json_parser::token_type::LBRACE)] == 1);
+}
+#endif
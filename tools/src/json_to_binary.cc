@@ -0,0 +1,37 @@
+#include <json_parser.hpp>
+
+#include <fstream>
+#include <iostream>
+
+// converts a JSON file into a binary document that can be loaded with
+// json_parser::mapped_file
+int main(int argc, char** argv)
+{
+  if (argc != 3) {
+    std::cerr << "usage: " << argv[0] << " input.json output.jpb" << std::endl;
+    return 2;
+  }
+
+  try {
+    std::ifstream input(argv[1]);
+    if (!input) {
+      std::cerr << "could not open " << argv[1] << std::endl;
+      return 1;
+    }
+
+    json_parser::value document = json_parser::parse(input);
+
+    std::ofstream output(argv[2], std::ios::binary);
+    json_parser::write_binary(document, output);
+
+    if (!output) {
+      std::cerr << "could not write " << argv[2] << std::endl;
+      return 1;
+    }
+  } catch (std::exception& e) {
+    std::cerr << argv[1] << ": " << e.what() << std::endl;
+    return 1;
+  }
+
+  return 0;
+}